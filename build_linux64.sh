@@ -1 +1 @@
-g++ -O3 -o bin/bsm src/Main.cpp src/bsmlib.cpp -Iinclude -std=c++17
\ No newline at end of file
+g++ -O3 -o bin/bsm src/Main.cpp src/bsmlib.cpp src/KeyIndex.cpp -Iinclude -std=c++17 -pthread
\ No newline at end of file
@@ -0,0 +1,18 @@
+# Build the key table kernel check with AVX2, SSE2 and scalar kernels; each must pass, and all must agree
+results=""
+
+for flags in -mavx2 -msse2 -mno-sse2; do
+    g++ -O2 $flags -o bin/kernelcheck tests/KernelCheck.cpp src/bsmlib.cpp -Iinclude -std=c++17 || exit 1
+
+    result=$(./bin/kernelcheck) || { echo "$result"; echo "FAILED: $flags"; exit 1; }
+    echo "$flags: $result"
+
+    results="$results$(echo "$result" | tail -n 1)\n"
+done
+
+rm -f bin/kernelcheck
+
+if [ $(printf "$results" | sort -u | wc -l) -ne 1 ]; then
+    echo "FAILED: kernel variants disagree"
+    exit 1
+fi
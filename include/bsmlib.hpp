@@ -9,6 +9,7 @@
 #include <stdint.h>
 #include <fstream>
 #include <cstring>
+#include <memory>
 
 /*
 BSM File structure
@@ -43,6 +44,14 @@ namespace bsmlib {
         std::vector<uint8_t> data;
     };
 
+    struct KeyInfo {
+        std::string  name;
+        KeyType      type;
+        uint16_t     size;  // Size of value in bytes (4 for Integer and Float)
+    };
+
+    bool ReadKeyTable(std::string fname, std::vector<KeyInfo> &table);  // Read key table of file without loading data region
+
     class Data {
         public:
             std::map<std::string, Key> keys;    // Map of keynames to values
@@ -50,7 +59,7 @@ namespace bsmlib {
             void ClearKeys();                       // Clear all keys in structure
             void DeleteKey(std::string keyname);    // Delete key by name
 
-            bool KeyExists (std::string keyname);   // Returns true if key exists in structure
+            bool KeyExists (std::string keyname) const; // Returns true if key exists in structure
 
             void SetKey     (std::string keyname, Key key);                     // Set key using Key struct
             void SetInt     (std::string keyname, int value);                   // Set integer by name and value
@@ -58,17 +67,40 @@ namespace bsmlib {
             void SetString  (std::string keyname, std::string value);           // Set string by name and value
             void SetRaw     (std::string keyname, std::vector<uint8_t> data);   // Set raw by name and value
 
-            Key         GetKey      (std::string keyname);  // Get Key structure of key by name
-            int         GetInt      (std::string keyname);  // Get integer value of key by name
-            float       GetFloat    (std::string keyname);  // Get float value of key by name
-            std::string GetString   (std::string keyname);  // Get string value of key by name
+            Key         GetKey      (std::string keyname) const;    // Get Key structure of key by name
+            int         GetInt      (std::string keyname) const;    // Get integer value of key by name
+            float       GetFloat    (std::string keyname) const;    // Get float value of key by name
+            std::string GetString   (std::string keyname) const;    // Get string value of key by name
 
-            std::vector<uint8_t> GetRaw(std::string keyname);   // Get raw bytes of key
+            std::vector<uint8_t> GetRaw(std::string keyname) const; // Get raw bytes of key
 
             bool Load(std::string fname, bool clearFirst = true);   // Load file by name. clearFirst = call ClearKeys() automatically.
-            bool Save(std::string fname);                           // Save structure to file
+            bool LoadKey(std::string fname, std::string keyname);   // Load single key from file by name, without building the other keys
+            bool Save(std::string fname) const;                     // Save structure to file
 
             Data();                     // Default constructor
             Data(std::string fname);    // Constructs structure and loads file
     };
+
+    using Snapshot = std::shared_ptr<const Data>;   // Immutable structure, safe to read from many threads without locking
+
+    class SharedData {
+        public:
+            Snapshot Get() const;               // Get current snapshot. Stays valid for as long as it is held, even after a Publish().
+
+            void Publish(Data data);            // Atomically replace current snapshot. Readers holding the old one are unaffected.
+            bool Reload(std::string fname);     // Load file into a new snapshot and publish it. Current snapshot is kept on failure.
+
+            SharedData();                       // Default constructor (empty snapshot)
+            SharedData(std::string fname);      // Constructs holder and loads file
+
+            // Not copyable or movable, since that would access current without atomics. Share by reference or pointer.
+            SharedData(const SharedData &) = delete;
+            SharedData(SharedData &&) = delete;
+            SharedData &operator=(const SharedData &) = delete;
+            SharedData &operator=(SharedData &&) = delete;
+
+        private:
+            Snapshot current;                   // Only accessed through std::atomic_load / std::atomic_store
+    };
 }
\ No newline at end of file
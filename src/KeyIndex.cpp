@@ -0,0 +1,323 @@
+#include "KeyIndex.hpp"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+// Little-endian helpers for index file I/O
+static void PutInt(std::vector<uint8_t> &out, uint64_t value, int bytes) {
+    for(int i = 0; i < bytes; i++) out.push_back((uint8_t)((value >> (i * 8)) & 0xFF));
+}
+
+static bool GetInt(const std::vector<uint8_t> &in, size_t &pos, uint64_t &value, int bytes) {
+    if(pos + bytes > in.size()) return false;
+
+    value = 0;
+    for(int i = 0; i < bytes; i++) value |= (uint64_t)in[pos + i] << (i * 8);
+    pos += bytes;
+
+    return true;
+}
+
+static bool GetString(const std::vector<uint8_t> &in, size_t &pos, std::string &value, size_t length) {
+    if(pos + length > in.size()) return false;
+
+    value.assign(in.begin() + pos, in.begin() + pos + length);
+    pos += length;
+
+    return true;
+}
+
+// Glob match supporting '*' (any run of characters) and '?' (any one character)
+static bool GlobMatch(const std::string &pattern, const std::string &text) {
+    size_t p = 0, t = 0;
+    size_t star = std::string::npos, mark = 0;
+
+    while(t < text.size()) {
+        if(p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+            p++; t++;
+        }else if(p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            mark = t;
+        }else if(star != std::string::npos) {
+            p = star + 1;
+            t = ++mark;
+        }else {
+            return false;
+        }
+    }
+
+    while(p < pattern.size() && pattern[p] == '*') p++;
+
+    return p == pattern.size();
+}
+
+static const char     INDEX_MAGIC[4]  = { 'B', 'S', 'M', 'I' };
+static const uint8_t  INDEX_VERSION   = 1;
+
+void KeyIndex::Clear() {
+    files.clear();
+    keys.clear();
+}
+
+bool KeyIndex::Build(std::string dirname, IndexStats &stats) {
+    std::error_code ec, statec;
+
+    std::vector<IndexedFile> newfiles;
+
+    stats = IndexStats();
+
+    // Collect .bsm files in directory. Any directory that can't be read fails the build, since
+    // its files would otherwise look removed.
+    for(auto it = fs::recursive_directory_iterator(dirname, ec);
+        !ec && it != fs::recursive_directory_iterator();
+        it.increment(ec)) {
+
+        if(!it->is_regular_file(statec) || it->path().extension() != ".bsm") continue;
+
+        auto mtime = it->last_write_time(statec);
+        auto size  = it->file_size(statec);
+        if(statec) continue;
+
+        newfiles.push_back(IndexedFile {
+            it->path().lexically_relative(dirname).generic_string(),
+            (int64_t)mtime.time_since_epoch().count(),
+            (uint64_t)size
+        });
+    }
+
+    if(ec) return false;
+
+    std::sort(newfiles.begin(), newfiles.end(), [](const IndexedFile &a, const IndexedFile &b) {
+        return a.path < b.path;
+    });
+
+    // Match against previous index. Unchanged files keep their postings, others are re-read.
+    std::map<std::string, uint32_t> oldfiles;
+    std::vector<int64_t> remap(files.size(), -1);
+    std::vector<uint32_t> toscan;
+
+    for(uint32_t i = 0; i < files.size(); i++) oldfiles[files[i].path] = i;
+
+    for(uint32_t i = 0; i < newfiles.size(); i++) {
+        auto old = oldfiles.find(newfiles[i].path);
+
+        if( old != oldfiles.end() &&
+            files[old->second].mtime == newfiles[i].mtime &&
+            files[old->second].size == newfiles[i].size) {
+
+            remap[old->second] = i;
+            stats.reused++;
+        }else {
+            toscan.push_back(i);
+        }
+
+        if(old != oldfiles.end()) oldfiles.erase(old);
+    }
+
+    stats.removed = oldfiles.size();
+    stats.scanned = toscan.size();
+
+    // Read key tables of new & changed files in parallel
+    std::vector<std::vector<bsmlib::KeyInfo>> tables(toscan.size());
+    std::vector<uint8_t> readok(toscan.size(), 0);
+    std::atomic<size_t> next(0);
+
+    auto worker = [&]() {
+        for(size_t n = next++; n < toscan.size(); n = next++) {
+            auto path = (fs::path(dirname) / newfiles[toscan[n]].path).string();
+            readok[n] = bsmlib::ReadKeyTable(path, tables[n]);
+        }
+    };
+
+    size_t threadcount = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), toscan.size());
+    std::vector<std::thread> threads;
+
+    for(size_t i = 0; i < threadcount; i++) threads.emplace_back(worker);
+    for(auto &t : threads) t.join();
+
+    // Rebuild name table. Unreadable files stay in the file table (with no keys) so they aren't re-read until changed.
+    std::map<std::string, std::vector<KeyPosting>> newkeys;
+
+    for(auto &kp : keys) {
+        for(auto &posting : kp.second) {
+            if(remap[posting.file] < 0) continue;
+            newkeys[kp.first].push_back(KeyPosting { (uint32_t)remap[posting.file], posting.type, posting.size });
+        }
+    }
+
+    for(size_t n = 0; n < toscan.size(); n++) {
+        if(!readok[n]) {
+            stats.failed++;
+            continue;
+        }
+
+        for(auto &info : tables[n]) {
+            newkeys[info.name].push_back(KeyPosting { toscan[n], info.type, info.size });
+        }
+    }
+
+    for(auto &kp : newkeys) {
+        std::stable_sort(kp.second.begin(), kp.second.end(), [](const KeyPosting &a, const KeyPosting &b) {
+            return a.file < b.file;
+        });
+    }
+
+    files = std::move(newfiles);
+    keys  = std::move(newkeys);
+
+    return true;
+}
+
+std::vector<std::pair<std::string, KeyPosting>> KeyIndex::Query(std::string pattern) const {
+    std::vector<std::pair<std::string, KeyPosting>> results;
+
+    // Only names sharing the pattern's literal prefix can match; walk that range of the map.
+    auto prefix = pattern.substr(0, pattern.find_first_of("*?"));
+
+    for(auto it = keys.lower_bound(prefix); it != keys.end(); it++) {
+        if(it->first.compare(0, prefix.size(), prefix) != 0) break;
+        if(!GlobMatch(pattern, it->first)) continue;
+
+        for(auto &posting : it->second) results.push_back({ it->first, posting });
+    }
+
+    return results;
+}
+
+bool KeyIndex::Load(std::string fname) {
+    Clear();
+
+    std::ifstream file;
+    std::vector<uint8_t> filedata;
+
+    size_t   pos    = 0;
+    uint64_t value  = 0;
+
+    std::error_code ec;
+
+    // Load file bytes. Reading a directory would throw, so check for a regular file first.
+    if(!fs::is_regular_file(fname, ec)) return false;
+
+    file.open(fname, std::ios::binary);
+    if(!file.is_open()) return false;
+
+    filedata = std::vector<uint8_t>(
+        std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>()
+    );
+
+    // Check header
+    if(filedata.size() < 5) return false;
+    if(!std::equal(std::begin(INDEX_MAGIC), std::end(INDEX_MAGIC), filedata.begin())) return false;
+    if(filedata[4] != INDEX_VERSION) return false;
+
+    pos = 5;
+
+    // Parse file table
+    if(!GetInt(filedata, pos, value, 4)) return false;
+    if(value > (filedata.size() - pos) / 18) return false; // Count larger than remaining bytes allow
+    files.resize(value);
+
+    for(auto &f : files) {
+        if(!GetInt(filedata, pos, value, 2))        return false;
+        if(!GetString(filedata, pos, f.path, value)) return false;
+        if(!GetInt(filedata, pos, value, 8))        return false;
+        f.mtime = (int64_t)value;
+        if(!GetInt(filedata, pos, value, 8))        return false;
+        f.size = value;
+    }
+
+    // Parse name table
+    if(!GetInt(filedata, pos, value, 4)) return false;
+
+    for(uint64_t n = value; n > 0; n--) {
+        std::string keyname;
+
+        if(!GetInt(filedata, pos, value, 1))            return false;
+        if(!GetString(filedata, pos, keyname, value))   return false;
+        if(!GetInt(filedata, pos, value, 4))            return false;
+        if(value > (filedata.size() - pos) / 7)         return false;
+
+        auto &postings = keys[keyname];
+        postings.resize(value);
+
+        for(auto &posting : postings) {
+            if(!GetInt(filedata, pos, value, 4)) return false;
+            if(value >= files.size())           return false;
+            posting.file = value;
+            if(!GetInt(filedata, pos, value, 1)) return false;
+            posting.type = (bsmlib::KeyType)value;
+            if(!GetInt(filedata, pos, value, 2)) return false;
+            posting.size = value;
+        }
+    }
+
+    return true;
+}
+
+bool KeyIndex::Save(std::string fname) const {
+    std::ofstream file;
+    std::vector<uint8_t> filedata;
+    std::error_code ec;
+
+    // Header
+    filedata.insert(filedata.end(), std::begin(INDEX_MAGIC), std::end(INDEX_MAGIC));
+    filedata.push_back(INDEX_VERSION);
+
+    // File table
+    PutInt(filedata, files.size(), 4);
+
+    for(auto &f : files) {
+        PutInt(filedata, f.path.size(), 2);
+        filedata.insert(filedata.end(), f.path.begin(), f.path.end());
+        PutInt(filedata, (uint64_t)f.mtime, 8);
+        PutInt(filedata, f.size, 8);
+    }
+
+    // Name table
+    PutInt(filedata, keys.size(), 4);
+
+    for(auto &kp : keys) {
+        PutInt(filedata, kp.first.size(), 1);
+        filedata.insert(filedata.end(), kp.first.begin(), kp.first.end());
+        PutInt(filedata, kp.second.size(), 4);
+
+        for(auto &posting : kp.second) {
+            PutInt(filedata, posting.file, 4);
+            PutInt(filedata, (uint8_t)posting.type, 1);
+            PutInt(filedata, posting.size, 2);
+        }
+    }
+
+    // Write to temporary file, then replace, so readers never see a partial index
+    auto tmpname = fname + ".tmp";
+
+    file.open(tmpname, std::ios::out | std::ios::binary);
+    if(!file.good()) return false;
+
+    file.write((char *)(filedata.data()), filedata.size());
+    file.close();
+
+    if(!file.good()) {
+        fs::remove(tmpname, ec);
+        return false;
+    }
+
+    fs::rename(tmpname, fname, ec);
+
+    if(ec) {
+        fs::remove(tmpname, ec);
+        return false;
+    }
+
+    return true;
+}
+
+std::string KeyIndex::DefaultPath(std::string dirname) {
+    return (fs::path(dirname) / ".bsmindex").string();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <bsmlib.hpp>
+#include <vector>
+#include <map>
+#include <string>
+#include <stdint.h>
+
+/*
+Key index file structure (all integers little-endian)
+
+[4] - Magic ("BSMI")
+[1] - Format version
+
+[4] - File table size (# of files)
+[*] File table {
+    [2] - Path length
+    [*] - Path (relative to indexed directory)
+    [8] - Modification time
+    [8] - File size
+}
+
+[4] - Name table size (# of distinct key names)
+[*] Name table {
+    [1] - Name length
+    [*] - Name
+    [4] - Posting count
+    [*] Postings {
+        [4] - File table index
+        [1] - Type (see bsmlib::KeyType)
+        [2] - Value size
+    }
+}
+*/
+
+struct IndexedFile {
+    std::string  path;      // Path relative to indexed directory
+    int64_t      mtime;     // Modification time at time of scan
+    uint64_t     size;      // File size at time of scan
+};
+
+struct KeyPosting {
+    uint32_t         file;  // Index into KeyIndex::files
+    bsmlib::KeyType  type;
+    uint16_t         size;
+};
+
+struct IndexStats {
+    int scanned     = 0;    // Files (re)read because they are new or changed
+    int reused      = 0;    // Files carried over unchanged from previous index
+    int removed     = 0;    // Files no longer present in directory
+    int failed      = 0;    // Files that could not be read as BSM
+};
+
+class KeyIndex {
+    public:
+        std::vector<IndexedFile>                         files;  // Indexed files, sorted by path
+        std::map<std::string, std::vector<KeyPosting>>   keys;   // Map of keynames to files defining them
+
+        void Clear();   // Clear all files and keys
+
+        bool Build(std::string dirname, IndexStats &stats); // Scan directory for .bsm files, re-reading only new or changed files. Fails (index unchanged) if any directory is unreadable.
+
+        std::vector<std::pair<std::string, KeyPosting>> Query(std::string pattern) const;   // Find keys matching glob pattern ('*' and '?')
+
+        bool Load(std::string fname);           // Load index file by name
+        bool Save(std::string fname) const;     // Save index to file
+
+        static std::string DefaultPath(std::string dirname);    // Location of index file for directory
+};
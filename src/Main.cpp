@@ -1,4 +1,5 @@
 #include <bsmlib.hpp>
+#include "KeyIndex.hpp"
 #include <iostream>
 #include <filesystem>
 
@@ -16,6 +17,9 @@ enum class ToolError {
     UnkownAction,
     NoGivenAction,
     InvalidSyntax,
+    DirectoryOpenError,
+    IndexReadError,
+    IndexWriteError,
     Unknown
 };
 
@@ -38,6 +42,13 @@ void PrintHelp() {
         << "\t- When using 'get', bsmtool will list specified keys." << std::endl
         << "\t- When using 'remove', bsmtool will remove (delete) specified keys." << std::endl
         << std::endl
+        << "       bsm index (build <dir> | query <pattern> [dir])" << std::endl
+        << "\t- When using 'build', bsmtool will index the keys of all .bsm files in <dir> to \"<dir>/.bsmindex\"." << std::endl
+        << "\t  Only files which are new or changed since the last build are read." << std::endl
+        << "\t- When using 'query', bsmtool will list keys matching <pattern> using the index of [dir] (default: current directory)." << std::endl
+        << "\t  Patterns may use '*' (any characters) and '?' (any one character)." << std::endl
+        << "\t  To use 'build' or 'query' on a BSM file named 'index', write it as './index'." << std::endl
+        << std::endl
         << "Options:" << std::endl
         << "\t-i <name> <value>    Set integer value." << std::endl
         << "\t-f <name> <value>    Set float value." << std::endl
@@ -71,6 +82,15 @@ void PrintErr(ToolError errcode, std::vector<std::string> args = std::vector<std
                 std::cerr << "Invalid syntax: " << args[0] << std::endl;
             }
             break;
+        case ToolError::DirectoryOpenError:
+            std::cerr << "Could not open directory: \"" << args[0] << "\"." << std::endl;
+            break;
+        case ToolError::IndexReadError:
+            std::cerr << "Could not read index: \"" << args[0] << "\". Use 'bsm index build' to create it." << std::endl;
+            break;
+        case ToolError::IndexWriteError:
+            std::cerr << "Could not write index: \"" << args[0] << "\"." << std::endl;
+            break;
         default:
             std::cerr << "UNKOWN ERROR. THIS IS A BUG.";
             break;
@@ -79,7 +99,7 @@ void PrintErr(ToolError errcode, std::vector<std::string> args = std::vector<std
     std::cout << "Use option '--help' or '-h' for help with using bsmtool." << std::endl;
 }
 
-void PrintKey(bsmlib::Key &key, std::string keyname) {
+void PrintKey(const bsmlib::Key &key, std::string keyname) {
     switch(key.type) {
         case bsmlib::KeyType::Integer:
             std::cout << "(int)    \"" << keyname << "\" = " << key.value_int << std::endl;
@@ -99,7 +119,7 @@ void PrintKey(bsmlib::Key &key, std::string keyname) {
     }
 }
 
-void ListKeys(bsmlib::Data &data, std::string filename) {
+void ListKeys(const bsmlib::Data &data, std::string filename) {
     int keycount = data.keys.size();
 
     std::cout << "File \"" << filename << "\" (" << std::to_string(keycount) << " keys):" << std::endl;
@@ -112,7 +132,7 @@ void ListKeys(bsmlib::Data &data, std::string filename) {
     }
 }
 
-void DumpKeys(bsmlib::Data &data, std::string filename) {
+void DumpKeys(const bsmlib::Data &data, std::string filename) {
     int keycount = data.keys.size();
 
     std::cout << "File \"" << filename << "\" (" << std::to_string(keycount) << " keys):" << std::endl;
@@ -159,7 +179,7 @@ void DumpKeys(bsmlib::Data &data, std::string filename) {
     }
 }
 
-void GetKeys(bsmlib::Data &data, std::string filename, std::vector<std::string> keynames) {
+void GetKeys(const bsmlib::Data &data, std::string filename, std::vector<std::string> keynames) {
     std::cout << "In file \"" << filename << "\":" << std::endl;
 
     for(auto &name : keynames) {
@@ -187,6 +207,89 @@ void RemoveKeys(bsmlib::Data &data, std::string filename, std::vector<std::strin
     }
 }
 
+std::string KeyTypeName(bsmlib::KeyType type) {
+    switch(type) {
+        case bsmlib::KeyType::Integer:  return "(int)   ";
+        case bsmlib::KeyType::Float:    return "(float) ";
+        case bsmlib::KeyType::String:   return "(string)";
+        case bsmlib::KeyType::Raw:      return "(raw)   ";
+        default:                        return "(unkown)";
+    }
+}
+
+int BuildIndex(std::string dirname) {
+    KeyIndex index;
+    std::error_code ec;
+    auto indexname = KeyIndex::DefaultPath(dirname);
+
+    if(!std::filesystem::is_directory(dirname, ec)) {
+        PrintErr(ToolError::DirectoryOpenError, {dirname});
+        return 1;
+    }
+
+    // Start from previous index if there is one, so unchanged files aren't re-read
+    if(std::filesystem::exists(indexname, ec) && !index.Load(indexname)) {
+        std::cout << "Previous index \"" << indexname << "\" is unreadable, rebuilding." << std::endl;
+        index.Clear();
+    }
+
+    IndexStats stats;
+
+    if(!index.Build(dirname, stats)) {
+        PrintErr(ToolError::DirectoryOpenError, {dirname});
+        return 1;
+    }
+
+    if(!index.Save(indexname)) {
+        PrintErr(ToolError::IndexWriteError, {indexname});
+        return 1;
+    }
+
+    std::cout
+        << "Indexed " << index.files.size() << " files (" << index.keys.size() << " distinct keys) -> \"" << indexname << "\"." << std::endl
+        << "\tRead: " << stats.scanned << ", unchanged: " << stats.reused << ", removed: " << stats.removed << "." << std::endl;
+
+    if(stats.failed > 0) {
+        std::cout << "\tCould not read " << stats.failed << " files as BSM." << std::endl;
+    }
+
+    return 0;
+}
+
+int QueryIndex(std::string pattern, std::string dirname) {
+    KeyIndex index;
+    auto indexname = KeyIndex::DefaultPath(dirname);
+
+    if(!index.Load(indexname)) {
+        PrintErr(ToolError::IndexReadError, {indexname});
+        return 1;
+    }
+
+    auto results = index.Query(pattern);
+
+    std::cout << "Keys matching \"" << pattern << "\" (" << results.size() << " results):" << std::endl;
+
+    for(auto &r : results) {
+        auto &keyname = r.first;
+        auto &posting = r.second;
+
+        std::cout << KeyTypeName(posting.type) << " \"" << keyname << "\" <" << posting.size << " bytes> in \"" << index.files[posting.file].path << "\"" << std::endl;
+    }
+
+    return 0;
+}
+
+int RunIndex(std::vector<std::string> args) {
+    if(args.size() == 3 && args[1] == "build") {
+        return BuildIndex(args[2]);
+    }else if((args.size() == 3 || args.size() == 4) && args[1] == "query") {
+        return QueryIndex(args[2], (args.size() == 4) ? args[3] : ".");
+    }
+
+    PrintErr(ToolError::InvalidSyntax, {"Expected 'index build <dir>' or 'index query <pattern> [dir]'."});
+    return 1;
+}
+
 int main(int argc, char *argv[]) {
     std::vector<std::string> args(argv + 1, argv + argc);
     bsmlib::Data data;
@@ -208,6 +311,9 @@ int main(int argc, char *argv[]) {
         return 0;
     }
 
+    // Index commands don't operate on a single file. Other actions on a file named "index" still work as usual.
+    if(args[0] == "index" && args.size() >= 2 && (args[1] == "build" || args[1] == "query")) return RunIndex(args);
+
     // Parse
     auto state = ParseState::InFilename;
     auto curtype = bsmlib::KeyType::Null;
@@ -1,5 +1,194 @@
 #include <bsmlib.hpp>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Little-endian field readers
+static inline uint16_t ReadU16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t ReadU32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Length of NUL-terminated key name in 16-byte name field
+static inline uint8_t NameLength(const uint8_t *name) {
+#if defined(__SSE2__)
+    int zeros = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)name), _mm_setzero_si128()));
+
+    return zeros ? __builtin_ctz(zeros) : 16;
+#else
+    return std::find(name, name + 16, '\0') - name;
+#endif
+}
+
+// Check data bounds of all key table entries and measure their names in one pass. Uses AVX2 / SSE2 when the compiler
+// targets them, plain C++ otherwise. table must hold keycount * 21 readable bytes (keycount <= 255), and namelengths
+// keycount bytes.
+// Type bytes only decide which entries have data to bounds-check. Unknown types are deliberately accepted, not
+// rejected, since Load() has always skipped them.
+static bool ScanKeyTable(const uint8_t *table, int keycount, size_t datasize, uint8_t *namelengths) {
+    int i = 0;
+
+    // Entry end offsets are at most 0xFFFF + 0xFFFF, so clamping keeps signed 32-bit compares exact
+    int limit = (int)std::min<size_t>(datasize, 0x20000);
+
+#if defined(__AVX2__)
+    // 8 entries per step: gather type byte and offset/size words at a 21-byte stride
+    const __m256i stride = _mm256_setr_epi32(0, 21, 42, 63, 84, 105, 126, 147);
+    __m256i bad = _mm256_setzero_si256();
+
+    for(; i + 8 <= keycount; i += 8) {
+        const uint8_t *block = table + (i * 21);
+
+        __m256i types   = _mm256_and_si256(_mm256_i32gather_epi32((const int *)(block + 16), stride, 1), _mm256_set1_epi32(0xFF));
+        __m256i fields  = _mm256_i32gather_epi32((const int *)(block + 17), stride, 1);
+        __m256i ends    = _mm256_add_epi32(_mm256_and_si256(fields, _mm256_set1_epi32(0xFFFF)), _mm256_srli_epi32(fields, 16));
+        __m256i hasdata = _mm256_or_si256(
+            _mm256_cmpeq_epi32(types, _mm256_set1_epi32((int)bsmlib::KeyType::String)),
+            _mm256_cmpeq_epi32(types, _mm256_set1_epi32((int)bsmlib::KeyType::Raw))
+        );
+
+        bad = _mm256_or_si256(bad, _mm256_and_si256(hasdata, _mm256_cmpgt_epi32(ends, _mm256_set1_epi32(limit))));
+
+        for(int j = 0; j < 8; j++) namelengths[i + j] = NameLength(block + (j * 21));
+    }
+
+    if(!_mm256_testz_si256(bad, bad)) return false;
+#elif defined(__SSE2__)
+    // 4 entries per step. No gather in SSE2, so fields are loaded individually and checked together.
+    __m128i bad = _mm_setzero_si128();
+
+    for(; i + 4 <= keycount; i += 4) {
+        const uint8_t *block = table + (i * 21);
+        uint32_t words[4];
+
+        for(int j = 0; j < 4; j++) std::memcpy(&words[j], block + (j * 21) + 17, 4);
+
+        __m128i types   = _mm_setr_epi32(block[16], block[21 + 16], block[42 + 16], block[63 + 16]);
+        __m128i fields  = _mm_loadu_si128((const __m128i *)words);
+        __m128i ends    = _mm_add_epi32(_mm_and_si128(fields, _mm_set1_epi32(0xFFFF)), _mm_srli_epi32(fields, 16));
+        __m128i hasdata = _mm_or_si128(
+            _mm_cmpeq_epi32(types, _mm_set1_epi32((int)bsmlib::KeyType::String)),
+            _mm_cmpeq_epi32(types, _mm_set1_epi32((int)bsmlib::KeyType::Raw))
+        );
+
+        bad = _mm_or_si128(bad, _mm_and_si128(hasdata, _mm_cmpgt_epi32(ends, _mm_set1_epi32(limit))));
+
+        for(int j = 0; j < 4; j++) namelengths[i + j] = NameLength(block + (j * 21));
+    }
+
+    if(_mm_movemask_epi8(bad) != 0) return false;
+#endif
+
+    // Remaining entries (or all of them, without SIMD)
+    for(; i < keycount; i++) {
+        const uint8_t *entry = table + (i * 21);
+        auto vtype = (bsmlib::KeyType)(entry[16]);
+
+        if(vtype == bsmlib::KeyType::String || vtype == bsmlib::KeyType::Raw) {
+            if(ReadU16(entry + 17) + ReadU16(entry + 19) > limit) return false;
+        }
+
+        namelengths[i] = NameLength(entry);
+    }
+
+    return true;
+}
+
+// Index of last table entry with given name (as with Load), or -1. Compares whole 16-byte name fields at once.
+// table must hold keycount * 21 readable bytes.
+static int FindKeyEntry(const uint8_t *table, int keycount, std::string keyname) {
+    if(keyname.size() > 16) return -1;
+    if(keyname.find('\0') != std::string::npos) return -1;
+
+    // Name bytes plus terminator must match; bytes after the terminator are ignored, as in Load()
+    uint8_t  needle[16] = { 0 };
+    uint32_t mask       = (keyname.size() < 16) ? ((1u << (keyname.size() + 1)) - 1) : 0xFFFF;
+
+    std::memcpy(needle, keyname.data(), keyname.size());
+
+#if defined(__SSE2__)
+    __m128i vneedle = _mm_loadu_si128((const __m128i *)needle);
+#endif
+
+    // Search backwards: on duplicate names the last entry wins, as in Load()
+    for(int i = keycount - 1; i >= 0; i--) {
+        const uint8_t *entry = table + (i * 21);
+
+#if defined(__SSE2__)
+        uint32_t equal = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)entry), vneedle));
+#else
+        uint32_t equal = 0;
+        for(int j = 0; j < 16; j++) equal |= (uint32_t)(entry[j] == needle[j]) << j;
+#endif
+
+        if((equal & mask) == mask) return i;
+    }
+
+    return -1;
+}
+
+// Set key from table entry. Entry must already be validated by ScanKeyTable().
+static void LoadEntry(bsmlib::Data &data, const uint8_t *entry, std::string keyname, const uint8_t *dataregion) {
+    auto     vtype  = (bsmlib::KeyType)(entry[16]);
+    uint32_t value  = ReadU32(entry + 17);
+
+    int data_offset = ReadU16(entry + 17);
+    int data_size   = ReadU16(entry + 19);
+
+    if(vtype == bsmlib::KeyType::Integer) {
+        data.SetInt(keyname, (int)value);
+    } else if(vtype == bsmlib::KeyType::Float) {
+        float fvalue = 0.0f;
+
+        std::memcpy(&fvalue, &value, 4);
+
+        data.SetFloat(keyname, fvalue);
+    } else if(vtype == bsmlib::KeyType::String) {
+        data.SetString(keyname, std::string (
+            dataregion + data_offset,
+            dataregion + data_offset + data_size
+        ));
+    } else if(vtype == bsmlib::KeyType::Raw) {
+        data.SetRaw(keyname, std::vector<uint8_t> (
+            dataregion + data_offset,
+            dataregion + data_offset + data_size
+        ));
+    }
+}
+
+// Read whole file & check header. On success, keycount and data_region_start describe the key table.
+static bool ReadBSMFile(std::string fname, std::vector<uint8_t> &filedata, int &keycount, int &data_region_start) {
+    std::ifstream file;
+
+    int filesize = 0;
+
+    // Load file bytes
+    file.open(fname, std::ios::binary);
+    if(!file.is_open()) return false;
+
+    file.seekg(0, std::ios::end);
+    filesize = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    filedata.resize(filesize);
+    if(!file.read((char *)filedata.data(), filesize)) return false;
+
+    // Check file validity
+    if(filesize < 22) return false; // Impossibly small size
+    if(filesize < (filedata[0] * 21 + 1)) return false; // Does not match header
+
+    keycount            = filedata[0];
+    data_region_start   = 1 + (keycount * 21);
+
+    return true;
+}
+
 void bsmlib::Data::ClearKeys() {
     keys.clear();
 }
@@ -8,7 +197,7 @@ void bsmlib::Data::DeleteKey(std::string keyname) {
     keys.erase(keyname);
 }
 
-bool bsmlib::Data::KeyExists(std::string keyname) {
+bool bsmlib::Data::KeyExists(std::string keyname) const {
     return keys.count(keyname) > 0;
 }
 
@@ -73,8 +262,10 @@ void bsmlib::Data::SetRaw(std::string keyname, std::vector<uint8_t> data) {
     });
 }
 
-bsmlib::Key bsmlib::Data::GetKey(std::string keyname) {
-    return (keys.count(keyname) > 0) ? keys[keyname] : Key {
+bsmlib::Key bsmlib::Data::GetKey(std::string keyname) const {
+    auto it = keys.find(keyname);
+
+    return (it != keys.end()) ? it->second : Key {
         KeyType::Null,
         "",
         0,
@@ -83,25 +274,30 @@ bsmlib::Key bsmlib::Data::GetKey(std::string keyname) {
     };
 }
 
-int bsmlib::Data::GetInt(std::string keyname) {
-    if(keys.count(keyname) > 0) return keys[keyname].value_int;
+int bsmlib::Data::GetInt(std::string keyname) const {
+    auto it = keys.find(keyname);
+    if(it != keys.end()) return it->second.value_int;
 
     return 0;
 }
 
-float bsmlib::Data::GetFloat(std::string keyname) {
-    if(keys.count(keyname) > 0) return keys[keyname].value_float;
+float bsmlib::Data::GetFloat(std::string keyname) const {
+    auto it = keys.find(keyname);
+    if(it != keys.end()) return it->second.value_float;
 
     return 0.0f;
 }
 
-std::string bsmlib::Data::GetString(std::string keyname) {
-    if(keys.count(keyname) > 0) return keys[keyname].value_string;
+std::string bsmlib::Data::GetString(std::string keyname) const {
+    auto it = keys.find(keyname);
+    if(it != keys.end()) return it->second.value_string;
+
     return "";
 }
 
-std::vector<uint8_t> bsmlib::Data::GetRaw(std::string keyname) {
-    if(keys.count(keyname) > 0) return keys[keyname].data;
+std::vector<uint8_t> bsmlib::Data::GetRaw(std::string keyname) const {
+    auto it = keys.find(keyname);
+    if(it != keys.end()) return it->second.data;
 
     return std::vector<uint8_t>();
 }
@@ -109,95 +305,62 @@ std::vector<uint8_t> bsmlib::Data::GetRaw(std::string keyname) {
 bool bsmlib::Data::Load(std::string fname, bool clearFirst) {
     if(clearFirst) keys.clear();
 
-    std::ifstream file;
+    int data_region_start   = 0,
+        keycount            = 0;
+
+    uint8_t namelengths[255];
+
+    std::vector<uint8_t> filedata;
+
+    if(!ReadBSMFile(fname, filedata, keycount, data_region_start)) return false;
+
+    // Validate whole table before setting any keys
+    const uint8_t *table        = filedata.data() + 1;
+    const uint8_t *dataregion   = filedata.data() + data_region_start;
 
+    if(!ScanKeyTable(table, keycount, filedata.size() - data_region_start, namelengths)) return false;
+
+    // Parse file
+    for(int i = 0; i < keycount; i++) {
+        const uint8_t *entry = table + (i * 21);
+
+        LoadEntry(*this, entry, std::string((const char *)entry, namelengths[i]), dataregion);
+    }
+
+    return true;
+}
+
+bool bsmlib::Data::LoadKey(std::string fname, std::string keyname) {
     int data_region_start   = 0,
         keycount            = 0,
-        filesize            = 0;
+        index               = 0;
+
+    uint8_t namelengths[255];
 
     std::vector<uint8_t> filedata;
 
-    // Load file bytes
-    file.open(fname, std::ios::binary);
-    if(!file.is_open()) return false;
+    if(!ReadBSMFile(fname, filedata, keycount, data_region_start)) return false;
 
-    file.unsetf(std::ios::skipws);
+    const uint8_t *table        = filedata.data() + 1;
+    const uint8_t *dataregion   = filedata.data() + data_region_start;
 
-    file.seekg(0, std::ios::end);
-    filesize = file.tellg();
-    file.seekg(0, std::ios::beg);
+    // Reject the same files Load() would
+    if(!ScanKeyTable(table, keycount, filedata.size() - data_region_start, namelengths)) return false;
 
-    filedata.reserve(filesize);
-    filedata.insert(
-        filedata.begin(),
-        std::istream_iterator<uint8_t>(file),
-        std::istream_iterator<uint8_t>()
-    );
+    // Entries of unknown type are skipped by Load(), so keep looking in earlier entries
+    index = keycount;
 
-    // Check file validity
-    if(filesize < 22) return false; // Impossibly small size
-    if(filesize < (filedata[0] * 21 + 1)) return false; // Does not match header
+    do {
+        index = FindKeyEntry(table, index, keyname);
+        if(index < 0) return false;
+    } while((KeyType)(table[index * 21 + 16]) > KeyType::Raw);
 
-    // Parse file
-    data_region_start   = 1 + (filedata[0] * 21);
-    keycount            = filedata[0];
-
-    for(int i = 1; i < data_region_start; i += 21) {
-        KeyType vtype   = (KeyType)(filedata[i + 16]);
-        auto    keyname = std::string(filedata.begin() + i, filedata.begin() + i + 16);
-
-        keyname.erase(std::find(keyname.begin(), keyname.end(), '\0'), keyname.end());
-
-        if(vtype == KeyType::Integer) {
-            SetInt(keyname,
-                (filedata[i + 17 + 0] << 0)  +
-                (filedata[i + 17 + 1] << 8)  +
-                (filedata[i + 17 + 2] << 16) +
-                (filedata[i + 17 + 3] << 24)
-            );
-        } else if(vtype == KeyType::Float) {
-            float value = 0.0f;
-
-            uint32_t valbytes =
-                (filedata[i + 17 + 0] << 0)  +
-                (filedata[i + 17 + 1] << 8)  +
-                (filedata[i + 17 + 2] << 16) +
-                (filedata[i + 17 + 3] << 24) ;
-
-            std::memcpy(&value, &valbytes, 4);
-
-            SetFloat(keyname, value);
-        } else if(vtype == KeyType::String) {
-            int data_offset = (filedata[i + 17 + 0]) + (filedata[i + 17 + 1] << 8);
-            int data_size   = (filedata[i + 17 + 2]) + (filedata[i + 17 + 3] << 8);
-
-            if(data_offset + data_size < filedata.size()) {
-                SetString(keyname, std::string (
-                    filedata.begin() + data_region_start + data_offset,
-                    filedata.begin() + data_region_start + data_offset + data_size
-                ));
-            }else {
-                return false;
-            }
-        } else if(vtype == KeyType::Raw) {
-            int data_offset = (filedata[i + 17 + 0]) + (filedata[i + 17 + 1] << 8);
-            int data_size   = (filedata[i + 17 + 2]) + (filedata[i + 17 + 3] << 8);
-
-            if(data_offset + data_size < filedata.size()) {
-                SetRaw(keyname, std::vector<uint8_t> (
-                    filedata.begin() + data_region_start + data_offset,
-                    filedata.begin() + data_region_start + data_offset + data_size
-                ));
-            }else {
-                return false;
-            }
-        }
-    }
+    LoadEntry(*this, table + (index * 21), keyname, dataregion);
 
     return true;
 }
 
-bool bsmlib::Data::Save(std::string fname) {
+bool bsmlib::Data::Save(std::string fname) const {
     std::ofstream file;
 
     std::vector<uint8_t> tableregion;
@@ -268,4 +431,97 @@ bsmlib::Data::Data() {
 
 bsmlib::Data::Data(std::string fname) : Data(){
     Load(fname);
+}
+
+bsmlib::Snapshot bsmlib::SharedData::Get() const {
+    return std::atomic_load(&current);
+}
+
+void bsmlib::SharedData::Publish(Data data) {
+    std::atomic_store(&current, Snapshot(std::make_shared<const Data>(std::move(data))));
+}
+
+bool bsmlib::SharedData::Reload(std::string fname) {
+    Data data;
+
+    // Load off to the side; readers keep using the current snapshot meanwhile
+    if(!data.Load(fname)) return false;
+
+    Publish(std::move(data));
+
+    return true;
+}
+
+bsmlib::SharedData::SharedData() {
+    current = std::make_shared<const Data>();
+}
+
+bsmlib::SharedData::SharedData(std::string fname) : SharedData() {
+    Reload(fname);
+}
+
+bool bsmlib::ReadKeyTable(std::string fname, std::vector<KeyInfo> &table) {
+    table.clear();
+
+    std::ifstream file;
+
+    int data_region_start   = 0,
+        keycount            = 0,
+        filesize            = 0;
+
+    uint8_t namelengths[255];
+
+    std::vector<uint8_t> tabledata;
+
+    // Open file & get size
+    file.open(fname, std::ios::binary);
+    if(!file.is_open()) return false;
+
+    file.seekg(0, std::ios::end);
+    filesize = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    // Check file validity
+    if(filesize < 22) return false; // Impossibly small size
+
+    keycount            = file.get();
+    data_region_start   = 1 + (keycount * 21);
+
+    if(filesize < data_region_start) return false; // Does not match header
+
+    // Read key table only
+    tabledata.resize(keycount * 21);
+    if(!file.read((char *)tabledata.data(), tabledata.size())) return false;
+
+    if(!ScanKeyTable(tabledata.data(), keycount, filesize - data_region_start, namelengths)) return false;
+
+    std::map<std::string, size_t> seen;    // Keyname -> position in table, so duplicates collapse like in Load()
+
+    table.reserve(keycount);
+
+    for(int i = 0; i < keycount; i++) {
+        const uint8_t *entry = tabledata.data() + (i * 21);
+
+        KeyType vtype   = (KeyType)(entry[16]);
+        auto    keyname = std::string((const char *)entry, namelengths[i]);
+        auto    info    = KeyInfo { keyname, vtype, 4 };
+
+        if(vtype == KeyType::String || vtype == KeyType::Raw) {
+            info.size = ReadU16(entry + 19);
+        } else if(vtype != KeyType::Integer && vtype != KeyType::Float) {
+            continue; // Unknown types are skipped by Load()
+        }
+
+        // Later entries with the same name replace earlier ones
+        auto it = seen.find(keyname);
+
+        if(it != seen.end()) {
+            table[it->second] = info;
+        }else {
+            seen[keyname] = table.size();
+            table.push_back(info);
+        }
+    }
+
+    return true;
 }
\ No newline at end of file
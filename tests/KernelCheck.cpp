@@ -0,0 +1,140 @@
+#include <bsmlib.hpp>
+#include <filesystem>
+#include <random>
+#include <cstdio>
+
+/*
+Key table kernel check
+
+Loads a fixed set of generated (often malformed) BSM files and checks that Load, LoadKey and
+ReadKeyTable agree with each other. Prints a checksum of all results, so builds using different
+kernels (AVX2, SSE2, scalar) can be compared by check_linux64.sh.
+*/
+
+static uint64_t checksum = 1469598103934665603ull;  // FNV-1a
+
+static void Hash(const void *data, size_t size) {
+    for(size_t i = 0; i < size; i++) {
+        checksum ^= ((const uint8_t *)data)[i];
+        checksum *= 1099511628211ull;
+    }
+}
+
+static void HashKey(const std::string &keyname, const bsmlib::Key &key) {
+    uint8_t type = (uint8_t)key.type;
+
+    Hash(keyname.data(), keyname.size());
+    Hash(&type, 1);
+    Hash(key.data.data(), key.data.size());
+}
+
+// Random key table with names of every length, stray bytes after terminators, unknown types,
+// duplicate names and out-of-bounds data, followed by a random data region.
+static std::vector<uint8_t> MakeFile(std::mt19937 &rng) {
+    std::vector<uint8_t> filedata;
+
+    int keycount = rng() % 40;
+    int datasize = rng() % 300;
+
+    filedata.push_back(keycount);
+
+    for(int k = 0; k < keycount; k++) {
+        int namelength = rng() % 17;
+
+        for(int j = 0; j < 16; j++) {
+            filedata.push_back((j < namelength) ? ('a' + rng() % 3) : ((rng() % 8) ? 0 : 'z'));
+        }
+
+        filedata.push_back(rng() % 6);
+
+        int offset = rng() % (datasize + 5);
+        int size   = rng() % (datasize + 5);
+
+        if(rng() % 50 == 0) {
+            offset  = rng() % 65536;
+            size    = rng() % 65536;
+        }
+
+        filedata.push_back(offset & 0xFF); filedata.push_back(offset >> 8);
+        filedata.push_back(size & 0xFF);   filedata.push_back(size >> 8);
+    }
+
+    for(int i = 0; i < datasize; i++) filedata.push_back(rng());
+
+    return filedata;
+}
+
+int main() {
+    std::mt19937 rng(1);
+    auto fname = (std::filesystem::temp_directory_path() / "bsm_kernelcheck.bsm").string();
+
+    int files = 0, valid = 0, errors = 0;
+
+    for(; files < 20000; files++) {
+        auto filedata = MakeFile(rng);
+
+        std::ofstream file(fname, std::ios::out | std::ios::binary);
+        file.write((char *)filedata.data(), filedata.size());
+        file.close();
+
+        bsmlib::Data data;
+        std::vector<bsmlib::KeyInfo> table;
+
+        bool loaded = data.Load(fname);
+        bool scanned = bsmlib::ReadKeyTable(fname, table);
+
+        Hash(&loaded, 1);
+
+        if(loaded != scanned) {
+            std::printf("File %d: Load() = %d, ReadKeyTable() = %d\n", files, loaded, scanned);
+            errors++;
+            continue;
+        }
+
+        if(!loaded) continue;
+
+        valid++;
+
+        // ReadKeyTable must describe exactly the keys Load produced
+        if(table.size() != data.keys.size()) {
+            std::printf("File %d: ReadKeyTable() found %zu keys, Load() %zu\n", files, table.size(), data.keys.size());
+            errors++;
+        }
+
+        for(auto &info : table) {
+            auto key  = data.GetKey(info.name);
+            auto size = (info.type == bsmlib::KeyType::String || info.type == bsmlib::KeyType::Raw) ? key.data.size() : 4;
+
+            if(key.type != info.type || size != info.size) {
+                std::printf("File %d: ReadKeyTable() and Load() disagree on \"%s\"\n", files, info.name.c_str());
+                errors++;
+            }
+        }
+
+        // LoadKey must find every key Load produced, with the same value
+        for(auto &kp : data.keys) {
+            bsmlib::Data single;
+
+            HashKey(kp.first, kp.second);
+
+            if(!single.LoadKey(fname, kp.first) || single.GetKey(kp.first).data != kp.second.data) {
+                std::printf("File %d: LoadKey() and Load() disagree on \"%s\"\n", files, kp.first.c_str());
+                errors++;
+            }
+        }
+
+        // ...and nothing else
+        bsmlib::Data other;
+
+        if(other.LoadKey(fname, "zzzzzzzzzzzzzzzzz") || other.LoadKey(fname, "c") != data.KeyExists("c")) {
+            std::printf("File %d: LoadKey() and Load() disagree on keys Load() didn't produce\n", files);
+            errors++;
+        }
+    }
+
+    std::filesystem::remove(fname);
+
+    std::printf("%d files, %d valid, %d errors, checksum %016llx\n", files, valid, errors, (unsigned long long)checksum);
+
+    return (errors > 0) ? 1 : 0;
+}